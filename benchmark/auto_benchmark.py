@@ -84,7 +84,7 @@ def process_data(data):
         ...
     }
     '''
-    processed_data = {operation_type: defaultdict(list) for operation_type in OPERATIONS}
+    processed_data = {operation_type: defaultdict(list) for operation_type in OPERATIONS + ("memory",)}
     for data_row in data:
         map_name, key_type, value_type = data_row["map"], data_row["key"], data_row["value"]
         identifier = f"{map_name}<{key_type},{value_type}>"
@@ -98,6 +98,13 @@ def process_data(data):
 
             processed_data[operation_type][identifier].append(data_point)
 
+        # Bytes per element after inserting the whole data-set
+        for memory_type, map_name in MEMORY_MEASUREMENTS.items():
+            if memory_type in data_row:
+                memory_identifier = f"{map_name or data_row['map']}<{key_type},{value_type}>"
+                bytes_per_element = round(data_row[memory_type][0] / data_size, 2)
+                processed_data["memory"][memory_identifier].append((data_size, bytes_per_element))
+
     return processed_data
 
 def write_data(data, output_path):
@@ -112,6 +119,9 @@ FORCE_BENCHMARK = True
 # Operations that the benchmark will parse
 OPERATIONS = ("insert", "find", "erase")
 
+# Memory measurements that the benchmark will parse and the map they belong to, None being the benchmarked map
+MEMORY_MEASUREMENTS = {"memory": None, "std-memory": "std::unordered_map"}
+
 DATASET_DIR = "datasets\\"
 RESULTS_DIR = "results\\"
 
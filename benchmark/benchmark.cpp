@@ -10,7 +10,16 @@
 #include <numeric>
 #include <cmath>
 
+#if defined(_WIN32)
+#   include <windows.h>
+#   include <psapi.h>
+#   pragma comment(lib, "psapi.lib")
+#else
+#   include <sys/resource.h>
+#endif
+
 #include "../map.h"
+#include "../memory.h"
 
 
 // USER DEFINED --------------------------------------------------------------------------
@@ -51,6 +60,19 @@ static std::unordered_map<std::type_index, const char*> type_names = {
 static MapType filled_map;
 
 using KeyValueType = std::pair<KeyType, ValueType>;
+
+// The same map with its allocator wrapped in jvn::CountingAllocator, counting into jvn::AllocationCounter::global()
+template <class Map>
+struct Counted;
+
+template <template <class...> class Map, class Kt, class Vt, class Hasher, class KeyEq, class Alloc>
+struct Counted<Map<Kt, Vt, Hasher, KeyEq, Alloc>> {
+    using type = Map<Kt, Vt, Hasher, KeyEq, jvn::CountingAllocator<typename Alloc::value_type, Alloc>>;
+};
+
+// Maps measured for memory footprint
+using CountedMapType = typename Counted<MapType>::type;
+using CountedStdMapType = typename Counted<std::unordered_map<KeyType, ValueType>>::type;
 using Clock = std::chrono::high_resolution_clock;
 using ClkNano = std::chrono::nanoseconds;
 using ClkMicro = std::chrono::microseconds;
@@ -84,6 +106,36 @@ ClkNano measureFind(const std::vector<KeyValueType>& data_vec) {
     return timeDifference(start, stop);
 }
 
+// Returns the bytes held after inserting every element and the most held at once while doing so
+template <class CountedMap>
+std::pair<size_t, size_t> measureMemory(const std::vector<KeyValueType>& data_vec) {
+    jvn::AllocationCounter& counter = jvn::AllocationCounter::global();
+    counter.reset();
+
+    CountedMap map;
+    for (auto key_value: data_vec)
+        map.insert(key_value);
+
+    return {counter.live_bytes, counter.peak_bytes};
+}
+
+// Peak resident set size of the whole process in bytes
+size_t peakRSS() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS info;
+    GetProcessMemoryInfo(GetCurrentProcess(), &info, sizeof(info));
+    return size_t(info.PeakWorkingSetSize);
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#   if defined(__APPLE__)
+    return size_t(usage.ru_maxrss);
+#   else
+    return size_t(usage.ru_maxrss) * 1024;
+#   endif
+#endif
+}
+
 ClkNano measureInsertion(const std::vector<KeyValueType>& data_vec) {
     MapType map;
 
@@ -146,6 +198,12 @@ void printData(ClkNano total_time, ClkNano avrg, ClkNano stddev, size_t num_elem
             << "Average per-element time: " << std::chrono::duration_cast<ClkNano>(avrg / num_elements).count() << "ns\n\n";
 }
 
+void printMemory(size_t live_bytes, size_t peak_bytes, size_t num_elements, std::string map_name) {
+    std::cout << "Memory of " << map_name << ": " << live_bytes << "B, peak " << peak_bytes << "B\n"
+            << "Bytes per element: " << double(live_bytes) / double(num_elements) << "B, peak " 
+                                    << double(peak_bytes) / double(num_elements) << "B\n\n";
+}
+
 void runBenchmark(const std::vector<KeyValueType>& data_vec, std::ostream& output) {
     fillMap(filled_map, data_vec);
 
@@ -160,6 +218,15 @@ void runBenchmark(const std::vector<KeyValueType>& data_vec, std::ostream& outpu
     auto [total_erase, avrg_erase, dev_erase] = measure(data_vec, measureErase, "erases");
     printData(total_erase, avrg_erase, dev_erase, data_size, "erases");
 
+    auto [live_memory, peak_memory] = measureMemory<CountedMapType>(data_vec);
+    printMemory(live_memory, peak_memory, data_size, type_names[typeid(MapType)]);
+
+    auto [live_std_memory, peak_std_memory] = measureMemory<CountedStdMapType>(data_vec);
+    printMemory(live_std_memory, peak_std_memory, data_size, "std::unordered_map");
+
+    size_t peak_rss = peakRSS();
+    std::cout << "Peak RSS: " << peak_rss << "B\n\n";
+
     if (output.good()) {
         output << "Map:\t" << type_names[typeid(MapType)] << '\n'
             << "Key:\t" << type_names[typeid(KeyType)] << '\n'
@@ -168,7 +235,10 @@ void runBenchmark(const std::vector<KeyValueType>& data_vec, std::ostream& outpu
             << "Data-Set:\t" << data_vec.size() << '\n'
             << "Insert:\t" << total_insertion.count() << ',' << avrg_insertion.count() << ',' << dev_insertion.count() << '\n'
             << "Find:\t" << total_find.count() << ',' << avrg_find.count() << ',' << dev_find.count() << '\n'
-            << "Erase:\t" << total_erase.count() << ',' << avrg_erase.count() << ',' << dev_erase.count() << '\n'; 
+            << "Erase:\t" << total_erase.count() << ',' << avrg_erase.count() << ',' << dev_erase.count() << '\n'
+            << "Memory:\t" << live_memory << ',' << peak_memory << '\n'
+            << "Std-Memory:\t" << live_std_memory << ',' << peak_std_memory << '\n'
+            << "Peak-RSS:\t" << peak_rss << '\n'; 
     }
 }
 
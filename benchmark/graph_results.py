@@ -32,7 +32,10 @@ def plot_graphs(data):
         plt.title(operation_type)
         plt.xscale('log')
         plt.xlabel('Map size')
-        plt.ylabel(f'Average {operation_type} time (ns)')
+        if operation_type == 'memory':
+            plt.ylabel('Bytes per element')
+        else:
+            plt.ylabel(f'Average {operation_type} time (ns)')
         plt.legend()
 
     plt.show()
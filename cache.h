@@ -0,0 +1,246 @@
+#ifndef JVN_ROBIN_HOOD_CACHE_
+#define JVN_ROBIN_HOOD_CACHE_
+
+#include "hash.h"
+#include "table.h"
+#include <utility>
+#include <tuple>
+#include <memory>
+#include <functional>
+
+namespace jvn
+{
+    JVN_PRAGMA_PACK_PUSH(1)
+    template <class Kt, class Vt>
+    struct cache_bucket {
+        // Distance from ideal hash position
+        uint8_t id;
+        // CLOCK reference bit, set on every hit and cleared by the passing hand
+        uint8_t referenced;
+        std::pair<Kt, Vt> key_value_pair;
+    };
+    JVN_PRAGMA_PACK_POP()
+
+namespace detail
+{
+    // The reference bit travels with the element
+    template <class Kt, class Vt>
+    struct bucket_traits<cache_bucket<Kt, Vt>> {
+        using bucket_type = cache_bucket<Kt, Vt>;
+        using value_type = std::pair<Kt, Vt>;
+
+        static void move_construct(bucket_type& dest, bucket_type& src) {
+            ::new (&(dest.key_value_pair)) value_type(std::move(src.key_value_pair));
+            dest.referenced = src.referenced;
+        }
+
+        static void swap(bucket_type& lhs, bucket_type& rhs) {
+            using std::swap;
+            swap(lhs.key_value_pair, rhs.key_value_pair);
+            std::swap(lhs.referenced, rhs.referenced);
+        }
+
+        static void destroy(bucket_type& bucket) noexcept { bucket.key_value_pair.~value_type(); }
+    };
+} // namespace detail
+
+    // A fixed capacity cache on top of a Robin Hood table. Once full, every insertion of a new key evicts
+    // an element chosen by the CLOCK (second-chance) policy. Never allocates after construction
+    template <class Kt, class Vt,
+            class Hasher = hash<Kt>,
+            class KeyEq = std::equal_to<Kt>,
+            class Alloc = std::allocator<cache_bucket<Kt, Vt>>>
+        class bounded_cache
+    {
+    public:
+        using hasher                = Hasher;
+        using key_equal             = KeyEq;
+        using allocator_type        = Alloc;
+        using size_type             = typename Alloc::size_type;
+        using difference_type       = typename Alloc::difference_type;
+        using key_type              = Kt;
+        using mapped_type           = Vt;
+
+        using bucket_type           = cache_bucket<key_type, mapped_type>;
+    private:
+        using m_value_type          = std::pair<key_type, mapped_type>;
+        using m_reduction           = typename hash_reduction<hasher>::type;
+        using m_table_type          = detail::robin_hood_table<bucket_type, allocator_type>;
+    public:
+
+        explicit bounded_cache(size_type capacity, float load_factor = 0.8f, allocator_type allocator = allocator_type())
+            :m_max_elems(capacity ? capacity : 1),
+            m_table(bucketCount(m_max_elems, load_factor), allocator),
+            m_hand(m_table.begin()) {}
+
+        bounded_cache(const bounded_cache&)             = delete;
+        bounded_cache& operator=(const bounded_cache&)  = delete;
+
+        bounded_cache(bounded_cache&& c)
+            :m_hasher(std::move(c.m_hasher)),
+            m_key_equal(std::move(c.m_key_equal)),
+            m_max_elems(c.m_max_elems),
+            m_table(std::move(c.m_table)),
+            m_hand(c.m_hand),
+            m_hits(c.m_hits),
+            m_misses(c.m_misses),
+            m_evictions(c.m_evictions) {}
+
+        // Returns a pointer to the mapped value or nullptr on a miss. Marks the element as recently used
+        template <class KeyTy>
+        mapped_type* find(const KeyTy& key) noexcept {
+            bucket_type* bucket = findBucket(key);
+            if (bucket == nullptr) {
+                ++m_misses;
+                return nullptr;
+            }
+
+            ++m_hits;
+            bucket->referenced = 1;
+            return &(bucket->key_value_pair.second);
+        }
+
+        // Doesn't mark the element as used or count towards the hits and misses
+        template <class KeyTy>
+        inline bool contains(const KeyTy& key) const noexcept { return findBucket(key) != nullptr; }
+
+        // Constructs the mapped value from args only if the key isn't present, evicting an element if full
+        template <class KeyTy, class... Args>
+        std::pair<mapped_type*, bool> try_emplace(KeyTy&& key, Args&&... args) {
+            auto [bucket, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(bucket, std::piecewise_construct,
+                            std::forward_as_tuple(std::forward<KeyTy>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
+            else
+                bucket->referenced = 1;
+
+            return std::pair<mapped_type*, bool>(&(bucket->key_value_pair.second), claimed);
+        }
+
+        template <class KeyTy, class MappedTy>
+        std::pair<mapped_type*, bool> insert_or_assign(KeyTy&& key, MappedTy&& obj) {
+            auto [bucket, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(bucket, std::forward<KeyTy>(key), std::forward<MappedTy>(obj));
+            else {
+                bucket->referenced = 1;
+                bucket->key_value_pair.second = std::forward<MappedTy>(obj);
+            }
+
+            return std::pair<mapped_type*, bool>(&(bucket->key_value_pair.second), claimed);
+        }
+
+        template <class KeyTy>
+        size_type erase(const KeyTy& key) noexcept {
+            bucket_type* bucket = findBucket(key);
+            if (bucket == nullptr)
+                return size_type(0);
+
+            m_table.erase(bucket);
+            return size_type(1);
+        }
+
+        inline void clear() noexcept { m_table.clear(); }
+
+        inline size_type size() const noexcept { return m_table.size(); }
+        inline bool empty() const noexcept { return !m_table.size(); }
+        // The number of elements after which insertions start evicting
+        inline size_type capacity() const noexcept { return m_max_elems; }
+
+        inline size_type hits() const noexcept { return m_hits; }
+        inline size_type misses() const noexcept { return m_misses; }
+        inline size_type evictions() const noexcept { return m_evictions; }
+        inline void reset_counters() noexcept { m_hits = m_misses = m_evictions = 0; }
+
+    private:
+        hasher m_hasher;
+        key_equal m_key_equal;
+
+        size_type m_max_elems       = 0;
+        m_table_type m_table;
+        // CLOCK hand, the next eviction candidate
+        bucket_type* m_hand         = nullptr;
+
+        size_type m_hits            = 0;
+        size_type m_misses          = 0;
+        size_type m_evictions       = 0;
+
+        template <class KeyTy>
+        inline bucket_type* findBucket(const KeyTy& key) const noexcept {
+            return m_table.find(hashAndTrim(key), matching(key)).first;
+        }
+
+        // Returns the bucket holding the key, or claims a bucket for it by displacing richer elements.
+        // A claimed bucket is left unconstructed and the caller must construct the key-value pair in it
+        // with constructAt()
+        template <class KeyTy>
+        std::pair<bucket_type*, bool> claimBucket(const KeyTy& key) {
+            // Evicting shifts elements around, so the key has to be looked up before
+            if (JVN_UNLIKELY(m_table.size() == m_max_elems)) {
+                if (bucket_type* bucket = findBucket(key))
+                    return std::pair<bucket_type*, bool>(bucket, false);
+
+                evict();
+            }
+
+            auto result = m_table.claim(hashAndTrim(key), matching(key));
+            if (result.claimed)
+                result.bucket->referenced = 0;
+
+            return std::pair<bucket_type*, bool>(result.bucket, result.claimed);
+        }
+
+        // Gives the bucket back if the construction throws. An element evicted to make room stays evicted
+        template <class... Args>
+        void constructAt(bucket_type* bucket, Args&&... args) {
+            try {
+                ::new (&(bucket->key_value_pair)) m_value_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                m_table.release(bucket);
+                throw;
+            }
+        }
+
+        template <class KeyTy>
+        inline auto matching(const KeyTy& key) const noexcept {
+            return [this, &key](const bucket_type& bucket) { return m_key_equal(bucket.key_value_pair.first, key); };
+        }
+
+        // Sweeps the hand over the buckets giving referenced elements a second chance
+        // The hand stays on the evicted bucket, which now holds the next shifted element
+        void evict() noexcept {
+            while (true) {
+                if (m_hand->id != uint8_t(-1)) {
+                    if (!m_hand->referenced)
+                        break;
+                    m_hand->referenced = 0;
+                }
+                m_hand = m_table.advance(m_hand);
+            }
+
+            m_table.erase(m_hand);
+            ++m_evictions;
+        }
+
+        // Since the capacity is always a power of two, the hash can be trimmed with a mask
+        // Hashers that pick fibonacci_reduction instead keep the top bits of the multiplied hash
+        template <class KeyTy>
+        inline size_type hashAndTrim(const KeyTy& key) const noexcept { 
+            return m_reduction::index(m_hasher(key), m_table.dec_capacity(), m_table.hash_shift()); 
+        }
+
+        // There has to be at least one empty bucket for the probing to terminate
+        static size_type bucketCount(size_type max_elems, float load_factor) noexcept {
+            size_type bucket_count = detail::closestPowerOfTwo(detail::loadedCapacity(max_elems, load_factor));
+            if (bucket_count <= max_elems)
+                bucket_count = detail::closestPowerOfTwo(max_elems + 1);
+
+            return bucket_count;
+        }
+    };
+
+} // namespace jvn
+
+#endif
@@ -3,6 +3,9 @@
 
 #include "utility.h"
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <cstring>
 #include <stdint.h>
 
 namespace jvn
@@ -21,7 +24,7 @@ namespace fnv
     JVN_INLINE_VAR constexpr size_t FNV_PRIME        = 16777619U;
 #endif
     
-inline size_t fnv_1a(size_t val, const unsigned char* bytes, size_t count) noexcept {
+inline constexpr size_t fnv_1a(size_t val, const unsigned char* bytes, size_t count) noexcept {
     for (size_t i = 0; i < count; ++i) {
         val ^= bytes[i];
         val *= FNV_PRIME;
@@ -46,11 +49,14 @@ JVN_INLINE_VAR constexpr size_t SEED = 0xe17a1465;
     size_t murmur_hash2(const unsigned char* bytes, size_t count) noexcept {
         size_t hash = SEED ^ (count * m);
 
-        const size_t* data = reinterpret_cast<const size_t*>(bytes);
-        const size_t* end = data + (count / 8);
+        const unsigned char* data = bytes;
+        const unsigned char* end = data + (count & ~size_t(7));
 
         while(data != end) {
-            size_t k = *data++;
+            // The bytes of a string view don't have to be aligned
+            size_t k;
+            std::memcpy(&k, data, sizeof(k));
+            data += sizeof(k);
 
             k *= m; 
             k ^= k >> r; 
@@ -60,7 +66,7 @@ JVN_INLINE_VAR constexpr size_t SEED = 0xe17a1465;
             hash *= m; 
         }
 
-        const unsigned char* data2 = reinterpret_cast<const unsigned char*>(data);
+        const unsigned char* data2 = data;
 
         switch(count & 7) {
         case 7: hash ^= size_t(data2[6]) << 48; // intentional fallthrough
@@ -80,8 +86,46 @@ JVN_INLINE_VAR constexpr size_t SEED = 0xe17a1465;
         return hash;
     } 
 
+    // MurmurHash64A reading the bytes one by one so it can be used in constant expressions
+    // Matches murmur_hash2(const unsigned char*, size_t) on little-endian platforms
+    inline constexpr size_t murmur_hash2(std::string_view str) noexcept {
+        const size_t count = str.size();
+        size_t hash = SEED ^ (count * m);
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            size_t k = 0;
+            for (size_t byte = 0; byte < 8; ++byte)
+                k |= size_t(static_cast<unsigned char>(str[i + byte])) << (8 * byte);
+
+            k *= m; 
+            k ^= k >> r; 
+            k *= m; 
+            
+            hash ^= k;
+            hash *= m; 
+        }
+
+        switch(count & 7) {
+        case 7: hash ^= size_t(static_cast<unsigned char>(str[i + 6])) << 48; // intentional fallthrough
+        case 6: hash ^= size_t(static_cast<unsigned char>(str[i + 5])) << 40; // intentional fallthrough
+        case 5: hash ^= size_t(static_cast<unsigned char>(str[i + 4])) << 32; // intentional fallthrough
+        case 4: hash ^= size_t(static_cast<unsigned char>(str[i + 3])) << 24; // intentional fallthrough
+        case 3: hash ^= size_t(static_cast<unsigned char>(str[i + 2])) << 16; // intentional fallthrough
+        case 2: hash ^= size_t(static_cast<unsigned char>(str[i + 1])) << 8;  // intentional fallthrough
+        case 1: hash ^= size_t(static_cast<unsigned char>(str[i]));           // intentional fallthrough
+                hash *= m;
+        };
+    
+        hash ^= hash >> r;
+        hash *= m;
+        hash ^= hash >> r;
+
+        return hash;
+    }
+
     // MurmurHash3 Int64 mix
-    inline size_t murmur_hash3_int(size_t k) noexcept {
+    inline constexpr size_t murmur_hash3_int(size_t k) noexcept {
         k ^= k >> 33;
         k *= 0xff51afd7ed558ccd;
         k ^= k >> 33;
@@ -133,8 +177,49 @@ JVN_INLINE_VAR constexpr size_t SEED = 0xe17a1465;
         return hash;
     } 
 
+    // MurmurHashNeutral2 usable in constant expressions
+    inline constexpr size_t murmur_hash2(std::string_view str) noexcept {
+        size_t count = str.size();
+        size_t hash = SEED ^ count;
+
+        size_t i = 0;
+        while(count >= 4)
+        {
+            size_t k;
+
+            k  = size_t(static_cast<unsigned char>(str[i]));
+            k |= size_t(static_cast<unsigned char>(str[i + 1])) << 8;
+            k |= size_t(static_cast<unsigned char>(str[i + 2])) << 16;
+            k |= size_t(static_cast<unsigned char>(str[i + 3])) << 24;
+
+            k *= m; 
+            k ^= k >> r; 
+            k *= m;
+
+            hash *= m;
+            hash ^= k;
+
+            i += 4;
+            count -= 4;
+        }
+        
+        switch(count)
+        {
+        case 3: hash ^= size_t(static_cast<unsigned char>(str[i + 2])) << 16;
+        case 2: hash ^= size_t(static_cast<unsigned char>(str[i + 1])) << 8;
+        case 1: hash ^= size_t(static_cast<unsigned char>(str[i]));
+                hash *= m;
+        };
+
+        hash ^= hash >> 13;
+        hash *= m;
+        hash ^= hash >> 15;
+
+        return hash;
+    }
+
     // MurmurHash3 Int32 mix
-    inline size_t murmur_hash3_int(size_t h) noexcept {
+    inline constexpr size_t murmur_hash3_int(size_t h) noexcept {
         h ^= h >> 16;
         h *= 0x85ebca6b;
         h ^= h >> 13;
@@ -148,6 +233,56 @@ JVN_INLINE_VAR constexpr size_t SEED = 0xe17a1465;
 } // namespace murmur_hash
 
 
+// Hash reduction policies
+// Turn a full hash into a bucket index of a power of two sized table, where
+// dec_capacity is the capacity - 1 and shift is the bitness - log2(capacity)
+
+// Keeps the low bits of the hash. Requires a well mixed hash
+struct mask_reduction
+{
+    static constexpr size_t index(size_t hash, size_t dec_capacity, uint8_t) noexcept {
+        return hash & dec_capacity;
+    }
+
+    // Index of a home bucket in a table that's smaller by shift_difference bits
+    static constexpr size_t narrow(size_t home, size_t dec_capacity, uint8_t) noexcept {
+        return home & dec_capacity;
+    }
+};
+
+// Fibonacci hashing. Multiplies by 2^bitness / golden ratio and keeps the top bits,
+// which spreads even sequential or poorly mixed keys over the whole table
+struct fibonacci_reduction
+{
+#if JVN(BITNESS) == 64
+    static constexpr size_t GOLDEN_RATIO = 11400714819323198485ULL;
+#else
+    static constexpr size_t GOLDEN_RATIO = 2654435769U;
+#endif
+
+    static constexpr size_t index(size_t hash, size_t, uint8_t shift) noexcept {
+        return (hash * GOLDEN_RATIO) >> shift;
+    }
+
+    static constexpr size_t narrow(size_t home, size_t, uint8_t shift_difference) noexcept {
+        return home >> shift_difference;
+    }
+};
+
+// Hashers choose their reduction with a nested reduction type, mask_reduction otherwise
+template <class Hasher, class = void>
+struct hash_reduction 
+{
+    using type = mask_reduction;
+};
+
+template <class Hasher>
+struct hash_reduction<Hasher, std::void_t<typename Hasher::reduction>>
+{
+    using type = typename Hasher::reduction;
+};
+
+
 // A function object that returns the hash of Kt type
 // By default it uses the MurmurHash2/3 algorithm
 // There is also THE FNV-1a implementation fnv::fnv_1a(...)
@@ -165,13 +300,13 @@ struct hash
 
 // There's probably a better way with SFINAE or some other conditional
 // enabling. But this is a pretty easy way to do specific specialization
-#define JVN_HASH_INT(Ty)                                        \
-    template <>                                                 \
-    struct hash<Ty>                                             \
-    {                                                           \
-        size_t operator()(const Ty key) const noexcept {        \
-            return murmur_hash::murmur_hash3_int(size_t(key));  \
-        }                                                       \
+#define JVN_HASH_INT(Ty)                                            \
+    template <>                                                     \
+    struct hash<Ty>                                                 \
+    {                                                               \
+        constexpr size_t operator()(const Ty key) const noexcept {  \
+            return murmur_hash::murmur_hash3_int(size_t(key));      \
+        }                                                           \
     }                                                           
 
 JVN_HASH_INT(bool);
@@ -190,6 +325,20 @@ JVN_HASH_INT(long long);
 JVN_HASH_INT(unsigned long);
 JVN_HASH_INT(unsigned long long);
 
+// Passes integer keys through unchanged and leaves the spreading to Fibonacci hashing
+// Cheaper than hash<Kt> for integer keys since it skips the MurmurHash3 mix
+template <class Kt>
+struct fibonacci_hash
+{
+    static_assert(std::is_integral_v<Kt> || std::is_enum_v<Kt>, "fibonacci_hash requires an integer key");
+
+    using reduction = fibonacci_reduction;
+
+    constexpr size_t operator()(const Kt key) const noexcept {
+        return size_t(key);
+    }
+};
+
 template <class Ty>
 struct hash<Ty*> 
 {
@@ -206,6 +355,28 @@ struct hash<std::string>
     }
 };
 
+template <>
+struct hash<std::string_view>
+{
+    size_t operator()(std::string_view str) const noexcept {
+        return murmur_hash::murmur_hash2(reinterpret_cast<const unsigned char*>(str.data()), str.size());
+    }
+};
+
+// A function object that returns the hash of Kt type in a constant expression
+// The integer hashes are already constexpr. String views are hashed a byte at a time,
+// which is slower than hash<std::string_view> at runtime but gives the same values on little-endian platforms
+template <class Kt>
+struct constexpr_hash : hash<Kt> {};
+
+template <>
+struct constexpr_hash<std::string_view>
+{
+    constexpr size_t operator()(std::string_view str) const noexcept {
+        return murmur_hash::murmur_hash2(str);
+    }
+};
+
 } // namespace jvn
 
 #endif
\ No newline at end of file
@@ -2,7 +2,15 @@
 #define JVN_ROBIN_HOOD_MAP_
 
 #include "hash.h"
+#include "stats.h"
+#include "table.h"
 #include <utility>
+#include <tuple>
+#include <memory>
+#include <type_traits>
+#include <thread>
+#include <vector>
+#include <exception>
 #include <cstring>
 
 namespace jvn
@@ -16,6 +24,20 @@ namespace jvn
     };
     JVN_PRAGMA_PACK_POP()
 
+namespace detail
+{
+    template <class Kt, class Vt>
+    struct bucket_traits<hash_bucket<Kt, Vt>> {
+        using bucket_type = hash_bucket<Kt, Vt>;
+        using value_type = std::pair<Kt, Vt>;
+
+        static void move_construct(bucket_type& dest, bucket_type& src) { ::new (&(dest.key_value_pair)) value_type(std::move(src.key_value_pair)); }
+        static void copy_construct(bucket_type& dest, const bucket_type& src) { ::new (&(dest.key_value_pair)) value_type(src.key_value_pair); }
+        static void swap(bucket_type& lhs, bucket_type& rhs) { using std::swap; swap(lhs.key_value_pair, rhs.key_value_pair); }
+        static void destroy(bucket_type& bucket) noexcept { bucket.key_value_pair.~value_type(); }
+    };
+} // namespace detail
+
     template <class Kt, class Vt, 
             class Hasher = hash<Kt>, 
             class KeyEq = std::equal_to<Kt>, 
@@ -37,6 +59,8 @@ namespace jvn
         using bucket_type           = hash_bucket<key_type, mapped_type>;
     private:
         using m_value_type          = std::pair<key_type, mapped_type>;
+        using m_reduction           = typename hash_reduction<hasher>::type;
+        using m_table_type          = detail::robin_hood_table<bucket_type, allocator_type>;
     public:
 
         class Iter
@@ -68,68 +92,45 @@ namespace jvn
         friend class Iter;
         using iterator              = Iter;
 
-        unordered_map() { 
-            initilize(16); 
-        }
+        unordered_map()
+            :m_table(16),
+            m_max_elems(maxElems()) {}
 
         unordered_map(size_type inital_capacity, float load_factor = 0.8f, size_type growth_factor = 2, allocator_type allocator = allocator_type())
             :M_LOAD_FACTOR(load_factor),
-            M_GROWTH_FACTOR(closestPowerOfTwo(growth_factor)),
-            m_allocator(allocator) { 
-            initilize(closestPowerOfTwo(inital_capacity)); 
-        }
+            M_GROWTH_FACTOR(detail::closestPowerOfTwo(growth_factor)),
+            m_table(detail::closestPowerOfTwo(inital_capacity), allocator),
+            m_max_elems(maxElems()) {}
 
         unordered_map(const unordered_map& m)
             :M_LOAD_FACTOR(m.M_LOAD_FACTOR),
             M_GROWTH_FACTOR(m.M_GROWTH_FACTOR),
-            m_allocator(m.m_allocator) {
-            m_bucket = m_allocator.allocate(m.m_dec_capacity + 2);
-            if (m_bucket == nullptr)
-                throw std::bad_alloc();
-
-            m_dec_capacity = m.m_dec_capacity;
-            m_max_elems = m.m_max_elems;
-            m_size = m.m_size;
-            m_bucket_end = m_bucket + m_dec_capacity + 2;
-
-            for (auto iter = m_bucket, other_iter = m.m_bucket; iter != m_bucket_end; ++iter, ++other_iter) {
-                iter->id = other_iter->id;
-                if (iter->id != uint8_t(-1))
-                    ::new (&(iter->key_value_pair)) m_value_type(other_iter->key_value_pair);
-            }
-            m_bucket_end->id = uint8_t(0);
+            m_hasher(m.m_hasher),
+            m_key_equal(m.m_key_equal),
+            m_table(m.m_table),
+            m_max_elems(m.m_max_elems) {
+            JVN_STATS(m_stats = m.m_stats;)
         }
 
         unordered_map(unordered_map&& m)
             :M_LOAD_FACTOR(m.M_LOAD_FACTOR),
             M_GROWTH_FACTOR(m.M_GROWTH_FACTOR),
-            m_allocator(std::move(m.m_allocator)),
-            m_bucket(m.m_bucket),
-            m_bucket_end(m.m_bucket_end),
-            m_dec_capacity(m.m_dec_capacity),
-            m_size(m.m_size),
+            m_hasher(std::move(m.m_hasher)),
+            m_key_equal(std::move(m.m_key_equal)),
+            m_table(std::move(m.m_table)),
             m_max_elems(m.m_max_elems){
-            m.m_bucket = nullptr;
-            m.m_bucket_end = nullptr;
-        }
-
-        ~unordered_map() {
-            for (bucket_type* iter = m_bucket; iter != m_bucket_end; ++iter)
-                if (iter->id != uint8_t(-1))
-                    iter->key_value_pair.~m_value_type();
-
-            m_allocator.deallocate(m_bucket, m_dec_capacity + 2);
+            JVN_STATS(m_stats = m.m_stats;)
         }
 
         void reserve(size_type size) {
-            size = loadedCapacity(size);
-            if (size > m_dec_capacity)
-                growTo(closestPowerOfTwo(size));
+            size = detail::loadedCapacity(size, M_LOAD_FACTOR);
+            if (size > m_table.dec_capacity())
+                growTo(detail::closestPowerOfTwo(size));
         }
 
         template <class KeyTy>
         inline mapped_type& operator[](KeyTy&& key) {
-            return insert(m_value_type(std::forward<KeyTy>(key), mapped_type())).first->second;
+            return try_emplace(std::forward<KeyTy>(key)).first->second;
         }
 
         template <class... Valtys>
@@ -138,190 +139,398 @@ namespace jvn
         }
 
         template <class ValTy = m_value_type>
-        std::pair<iterator, bool> insert(ValTy&& key_value_pair) {
-            if (JVN_UNLIKELY(m_size == m_max_elems))
-                growTo((m_dec_capacity + 1) * M_GROWTH_FACTOR);
-
-            uint8_t id = 0;
-            bucket_type* iter = m_bucket + hashAndTrim(key_value_pair.first);
-            while (true) {
-                // Empty slot found
-                if (iter->id == uint8_t(-1)) {
-                    iter->id = id;
-                    ::new (&(iter->key_value_pair)) m_value_type(std::forward<ValTy>(key_value_pair));
-                    break;
-                }
+        inline std::pair<iterator, bool> insert(ValTy&& key_value_pair) {
+            size_t hash = m_hasher(key_value_pair.first);
+            return insert(std::forward<ValTy>(key_value_pair), hash);
+        }
+
+        // hash has to be hash_function()(key_value_pair.first)
+        template <class ValTy = m_value_type>
+        std::pair<iterator, bool> insert(ValTy&& key_value_pair, size_t hash) {
+            auto [iter, claimed] = claimBucket(key_value_pair.first, hash);
+            if (claimed)
+                constructAt(iter, std::forward<ValTy>(key_value_pair));
+
+            return std::pair<iterator, bool>(iterator(iter), claimed);
+        }
 
-                // Rich found
-                if (iter->id < id) {
-                    insertFrom(advanceIter(iter), iter->id + 1, std::move(iter->key_value_pair));
-                    iter->id = id;
-                    iter->key_value_pair = std::forward<ValTy>(key_value_pair);
-                    break;
-                } 
+        // Constructs the mapped value from args only if the key isn't present
+        template <class KeyTy, class... Args>
+        std::pair<iterator, bool> try_emplace(KeyTy&& key, Args&&... args) {
+            auto [iter, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(iter, std::piecewise_construct, 
+                            std::forward_as_tuple(std::forward<KeyTy>(key)),
+                            std::forward_as_tuple(std::forward<Args>(args)...));
 
-                // Key found
-                if (JVN_UNLIKELY(iter->id == id && m_key_equal(key_value_pair.first, iter->key_value_pair.first)))
-                    return std::pair<iterator, bool>(iterator(iter), false);
+            return std::pair<iterator, bool>(iterator(iter), claimed);
+        }
+
+        template <class KeyTy, class MappedTy>
+        std::pair<iterator, bool> insert_or_assign(KeyTy&& key, MappedTy&& obj) {
+            auto [iter, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(iter, std::forward<KeyTy>(key), std::forward<MappedTy>(obj));
+            else
+                iter->key_value_pair.second = std::forward<MappedTy>(obj);
 
-                ++id;
-                iter = advanceIter(iter);
+            return std::pair<iterator, bool>(iterator(iter), claimed);
+        }
+
+        // Calls update_fn(mapped_type&) if the key is present, otherwise
+        // constructs the mapped value from the result of make_fn()
+        template <class KeyTy, class MakeFn, class UpdateFn>
+        std::pair<iterator, bool> upsert(KeyTy&& key, MakeFn&& make_fn, UpdateFn&& update_fn) {
+            auto [iter, claimed] = claimBucket(key);
+            if (claimed) {
+                // make_fn() has to run inside the try as well
+                try {
+                    ::new (&(iter->key_value_pair)) m_value_type(std::forward<KeyTy>(key), std::forward<MakeFn>(make_fn)());
+                }
+                catch (...) {
+                    m_table.release(iter);
+                    throw;
+                }
             }
-    
-            ++m_size;
-            return std::pair<iterator, bool>(iterator(iter), true);
+            else
+                std::forward<UpdateFn>(update_fn)(iter->key_value_pair.second);
+
+            return std::pair<iterator, bool>(iterator(iter), claimed);
+        }
+
+
+        // Inserts the elements of other whose keys aren't present, existing elements are kept
+        template <class MapTy, class = std::enable_if_t<std::is_same_v<std::decay_t<MapTy>, unordered_map>>>
+        void merge(MapTy&& other) {
+            mergeFrom(std::forward<MapTy>(other), [](mapped_type&, auto&&) {}, [](mapped_type& dest, auto&& src) {
+                dest = std::forward<decltype(src)>(src);
+            });
         }
 
+        // Like merge(), but calls combine_fn(mapped_type& dest, src) for keys present in both maps
+        template <class MapTy, class CombineFn, class = std::enable_if_t<std::is_same_v<std::decay_t<MapTy>, unordered_map>>>
+        void merge_with(MapTy&& other, CombineFn&& combine_fn) {
+            mergeFrom(std::forward<MapTy>(other), combine_fn, [&combine_fn](mapped_type& dest, auto&& src) {
+                mapped_type other_mapped = std::move(dest);
+                dest = std::forward<decltype(src)>(src);
+                combine_fn(dest, std::move(other_mapped));
+            });
+        }
+
+        inline void clear() noexcept { m_table.clear(); }
 
         template <class KeyTy>
-        size_type erase(KeyTy&& key) noexcept {
-            bucket_type* iter = find(std::forward<KeyTy>(key)).m_bucket_ptr;
-            if (iter == m_bucket_end)
+        inline size_type erase(KeyTy&& key) noexcept {
+            size_t hash = m_hasher(key);
+            return erase(std::forward<KeyTy>(key), hash);
+        }
+
+        // hash has to be hash_function()(key)
+        template <class KeyTy>
+        size_type erase(KeyTy&& key, size_t hash) noexcept {
+            // Not through find(), so erases aren't recorded as finds in the statistics
+            bucket_type* iter = m_table.find(trim(hash), matching(key)).first;
+            if (iter == nullptr)
                 return size_type(0);
 
-            // Traverse the bucket and swap elements with previous until
-            // an empty slot is found or an element with the 0 hash distance
-            bucket_type* next_iter = advanceIter(iter);
-            while (next_iter->id != uint8_t(0) && next_iter->id != uint8_t(-1)) {
-                iter->id = next_iter->id - 1;
-                using std::swap;
-                swap(iter->key_value_pair, next_iter->key_value_pair);
+            [[maybe_unused]] size_type shift_length = m_table.erase(iter);
+            JVN_STATS(m_stats.erase_shift.record(shift_length);)
+            return size_type(1);
+        }
 
-                iter = std::exchange(next_iter, advanceIter(next_iter));
+        template <class KeyTy>
+        inline iterator find(KeyTy&& key) const noexcept {
+            return find(key, m_hasher(key));
+        }
+
+        // hash has to be hash_function()(key). Lets callers hash a key once
+        // and reuse it across maps with the same hasher
+        template <class KeyTy>
+        iterator find(KeyTy&& key, size_t hash) const noexcept {
+            auto [bucket, distance] = m_table.find(trim(hash), matching(key));
+            if (JVN_UNLIKELY(bucket == nullptr)) {
+                JVN_STATS(m_stats.find_miss.record(distance);)
+                return end();
             }
 
-            iter->id = uint8_t(-1);
-            iter->key_value_pair.~m_value_type();
-            --m_size;
+            JVN_STATS(m_stats.find_hit.record(distance);)
+            return iterator(bucket);
+        }
 
-            return size_type(1);
+        // Hints the CPU to load the home bucket of hash ahead of a find, insert or erase
+        inline void prefetch(size_t hash) const noexcept { JVN_PREFETCH(m_table.begin() + trim(hash)); }
+
+        inline hasher hash_function() const { return m_hasher; }
+        inline key_equal key_eq() const { return m_key_equal; }
+
+        inline size_type size() const noexcept { return m_table.size(); }
+        inline bool empty() const noexcept { return !m_table.size(); }
+
+        inline size_type bucket_count() const noexcept { return m_table.capacity(); }
+        inline float load_factor() const noexcept { return float(m_table.size()) / float(m_table.capacity()); }
+        inline float max_load_factor() const noexcept { return M_LOAD_FACTOR; }
+
+        // Bytes held by the map itself, including the end() bucket. Doesn't
+        // include memory the keys and values allocate on their own
+        inline size_type memory_usage() const noexcept {
+            return sizeof(*this) + m_table.memory_usage();
         }
 
-        template <class KeyTy>
-        iterator find(KeyTy&& key) const noexcept {
-            uint8_t id = 0;
-            bucket_type* iter = m_bucket + hashAndTrim(key);
-            while (true) {
-                // Key found
-                if (iter->id == id && m_key_equal(iter->key_value_pair.first, key))
-                    return iterator(iter);
-
-                // Key not found
-                if (JVN_UNLIKELY(iter->id == uint8_t(-1) || iter->id < id))
-                    return end();
-
-                ++id;
-                iter = advanceIter(iter);
+
+        inline iterator begin() const noexcept { return iterator(m_table.begin()); }
+        inline iterator end() const noexcept { return iterator(m_table.end()); }
+
+        // Calls fn(value_type&) on every element. With JVN_ENABLE_OCCUPANCY_BITMAP it walks the
+        // occupancy bitmap, so empty buckets are skipped 64 at a time. Otherwise it walks the buckets
+        template <class Fn>
+        void for_each(Fn&& fn) const {
+            forEachIn(0, m_table.capacity(), fn);
+        }
+
+        // Splits the bucket array into equal chunks, one per thread, and calls fn(value_type&) on
+        // every element. fn must be safe to call concurrently. The first exception thrown is rethrown
+        template <class Fn>
+        void parallel_for_each(Fn&& fn, size_type num_threads = std::thread::hardware_concurrency()) const {
+            size_type capacity = m_table.capacity();
+            if (num_threads > capacity)
+                num_threads = capacity;
+            if (num_threads <= 1) {
+                forEachIn(0, capacity, fn);
+                return;
+            }
+
+            std::vector<std::exception_ptr> exceptions(num_threads);
+            auto run_chunk = [&](size_type chunk) {
+                try {
+                    forEachIn(capacity * chunk / num_threads, capacity * (chunk + 1) / num_threads, fn);
+                }
+                catch (...) {
+                    exceptions[chunk] = std::current_exception();
+                }
+            };
+
+            std::vector<std::thread> threads;
+            threads.reserve(num_threads - 1);
+            try {
+                for (size_type chunk = 1; chunk < num_threads; ++chunk)
+                    threads.emplace_back(run_chunk, chunk);
             }
+            catch (...) {
+                // Destroying a joinable thread terminates the process
+                for (auto& thread: threads)
+                    thread.join();
+                throw;
+            }
+
+            run_chunk(0);
+            for (auto& thread: threads)
+                thread.join();
+
+            for (auto& exception: exceptions)
+                if (exception)
+                    std::rethrow_exception(exception);
         }
 
-        inline size_type size() const noexcept { return m_size; }
-        inline bool empty() const noexcept { return !m_size; }
+#if JVN(STATS)
+        inline const map_stats& stats() const noexcept { return m_stats; }
+        inline void reset_stats() noexcept { m_stats = map_stats(); }
+#endif
+
+        // Scans the whole bucket array, cost is linear in the capacity
+        map_analysis analyze() const noexcept {
+            map_analysis analysis;
+            analysis.size = m_table.size();
+            analysis.bucket_count = bucket_count();
+            analysis.load_factor = load_factor();
+
+            // Start right after an empty bucket so no cluster gets split by the wrap-around
+            bucket_type* start = m_table.begin();
+            while (start != m_table.end() && start->id != uint8_t(-1))
+                ++start;
+            if (start == m_table.end()) {
+                // No empty buckets, the whole table is one cluster
+                for (bucket_type* iter = m_table.begin(); iter != m_table.end(); ++iter)
+                    analysis.displacement.record(iter->id);
+                if (m_table.size()) {
+                    analysis.cluster_length.record(m_table.size());
+                    analysis.cluster_count = 1;
+                }
+                return analysis;
+            }
 
+            size_t cluster_length = 0;
+            bucket_type* iter = start;
+            do {
+                iter = m_table.advance(iter);
+                if (iter->id != uint8_t(-1)) {
+                    analysis.displacement.record(iter->id);
+                    ++cluster_length;
+                }
+                else if (cluster_length) {
+                    analysis.cluster_length.record(cluster_length);
+                    ++analysis.cluster_count;
+                    cluster_length = 0;
+                }
+            } while (iter != start);
 
-        inline iterator begin() const noexcept { return iterator(m_bucket); }
-        inline iterator end() const noexcept { return iterator(m_bucket_end); }
+            return analysis;
+        }
 
     private:
         float M_LOAD_FACTOR         = 0.8f;
         size_type M_GROWTH_FACTOR   = 2;
 
-        allocator_type m_allocator;
         hasher m_hasher;
         key_equal m_key_equal;
 
-        bucket_type* m_bucket       = nullptr;
-        bucket_type* m_bucket_end   = nullptr;
-
-        size_type m_dec_capacity    = 0;
-        size_type m_size            = 0;
+        m_table_type m_table;
         // The number of elements that triggers growth
         size_type m_max_elems       = 0;
 
-        // Re-insert swapped rich element
-        inline void insertFrom(bucket_type* iter, uint8_t id, m_value_type&& key_value_pair) {
-            while (iter->id != uint8_t(-1)) {
-                // Rich found
-                if (iter->id < id) {
-                    using std::swap;
-                    swap(iter->id, id);
-                    swap(iter->key_value_pair, key_value_pair);
-                } 
-
-                ++id;
-                iter = advanceIter(iter);
+#if JVN(STATS)
+        // Mutable since find() is const. Not safe for concurrent readers
+        mutable map_stats m_stats;
+#endif
+
+        // Returns the bucket holding the key, or claims a bucket for it by displacing richer elements.
+        // A claimed bucket is left unconstructed and the caller must construct the key-value pair in it
+        // with constructAt(). The map only grows when a bucket is claimed, so a present key never
+        // invalidates iterators, and key may refer to an element of the map
+        template <class KeyTy>
+        inline std::pair<bucket_type*, bool> claimBucket(const KeyTy& key, size_t hash) {
+            if (JVN_UNLIKELY(m_table.size() == m_max_elems)) {
+                if (bucket_type* bucket = m_table.find(trim(hash), matching(key)).first)
+                    return std::pair<bucket_type*, bool>(bucket, false);
+
+                growTo(m_table.capacity() * M_GROWTH_FACTOR);
             }
 
-            iter->id = id;
-            ::new (&(iter->key_value_pair)) m_value_type(std::move(key_value_pair));
+            return claimBucketAt(key, trim(hash));
         }
 
-        // Since m_dec_capacity is always a power of two - 1, it's  value is all ones binary
-        // It can be used for fast trimming of the top bits of the hash, since % is a slow operation
         template <class KeyTy>
-        inline size_type hashAndTrim(KeyTy&& key) const noexcept { return m_hasher(std::forward<KeyTy>(key)) & m_dec_capacity; }
+        inline std::pair<bucket_type*, bool> claimBucket(const KeyTy& key) {
+            return claimBucket(key, m_hasher(key));
+        }
 
-        inline bucket_type* advanceIter(bucket_type* iter) const noexcept {
-            if (JVN_UNLIKELY(++iter == m_bucket_end))
-                    return m_bucket;
+        // Same as claimBucket() with an already trimmed hash. Never grows the map
+        template <class KeyTy>
+        std::pair<bucket_type*, bool> claimBucketAt(const KeyTy& key, size_type home) {
+            auto result = m_table.claim(home, matching(key));
+            JVN_STATS(
+                if (result.claimed) {
+                    m_stats.insert_displacement.record(result.distance);
+                    m_stats.insert_swaps += result.shifted;
+                }
+            )
+            return std::pair<bucket_type*, bool>(result.bucket, result.claimed);
+        }
 
-            return iter;
+        // Gives the bucket back if the construction throws, leaving the map as if nothing was inserted
+        template <class... Args>
+        void constructAt(bucket_type* bucket, Args&&... args) {
+            try {
+                ::new (&(bucket->key_value_pair)) m_value_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                m_table.release(bucket);
+                throw;
+            }
         }
 
-        void growTo(size_t new_capacity) {
-            bucket_type* prev_bucket = m_bucket,
-                    *prev_bucket_end = m_bucket_end;
+        template <class KeyTy>
+        inline auto matching(const KeyTy& key) const noexcept {
+            return [this, &key](const bucket_type& bucket) { return m_key_equal(bucket.key_value_pair.first, key); };
+        }
 
-            initilize(new_capacity);
+        // Merges other into this map, calling combine(dest, src) when a key is present in both maps.
+        // If the buckets got swapped with other, combine_swapped(dest, src) is called instead, where
+        // dest holds the mapped value of other and src the one originally in this map
+        template <class MapTy, class CombineFn, class SwappedCombineFn>
+        void mergeFrom(MapTy&& other, CombineFn&& combine, SwappedCombineFn&& combine_swapped) {
+            if (JVN_UNLIKELY(&other == this || other.empty()))
+                return;
+
+            // Positions in other are only valid here if both maps hash alike, which is
+            // only known for stateless hashers. Seeded ones always rehash
+            constexpr bool same_hash = std::is_empty_v<hasher>;
+
+            // A bigger table of a temporary can be stolen instead of growing this one
+            bool swapped = false;
+            if constexpr (same_hash && !std::is_lvalue_reference_v<MapTy> && std::allocator_traits<allocator_type>::is_always_equal::value) {
+                if (other.m_table.capacity() > m_table.capacity() &&
+                    other.size() + size() <= size_type(float(other.m_table.capacity()) * M_LOAD_FACTOR)) {
+                    swapBuckets(other);
+                    swapped = true;
+                }
+            }
 
-            // Re-insert
-            for (auto iter = prev_bucket; iter != prev_bucket_end; ++iter)
-                if (iter->id != uint8_t(-1))
-                    insert(std::move(iter->key_value_pair));
+            reserve(size() + other.size());
+
+            // The home bucket of an element is its position minus its hash distance. It can be narrowed
+            // down to a table that isn't bigger, since the index there uses a subset of the same bits
+            const bool reuse_home = same_hash && m_table.capacity() <= other.m_table.capacity();
+            const uint8_t shift_difference = m_table.hash_shift() - other.m_table.hash_shift();
+
+            // Walking other in bucket order visits our buckets in the same order
+            using source_reference = std::conditional_t<std::is_lvalue_reference_v<MapTy>, const m_value_type&, m_value_type&&>;
+            for (bucket_type* iter = other.m_table.begin(); iter != other.m_table.end(); ++iter) {
+                if (iter->id == uint8_t(-1))
+                    continue;
+
+                source_reference key_value_pair = static_cast<source_reference>(iter->key_value_pair);
+                size_type home = reuse_home ? m_reduction::narrow((size_type(iter - other.m_table.begin()) - iter->id) & other.m_table.dec_capacity(), 
+                                                                m_table.dec_capacity(), shift_difference)
+                                            : hashAndTrim(key_value_pair.first);
+
+                auto [bucket, claimed] = claimBucketAt(key_value_pair.first, home);
+                if (claimed)
+                    constructAt(bucket, std::forward<source_reference>(key_value_pair));
+                else if (swapped)
+                    combine_swapped(bucket->key_value_pair.second, std::forward<source_reference>(key_value_pair).second);
+                else
+                    combine(bucket->key_value_pair.second, std::forward<source_reference>(key_value_pair).second);
+            }
 
-            m_allocator.deallocate(prev_bucket, size_type(prev_bucket_end - prev_bucket + 1));
+            if constexpr (!std::is_lvalue_reference_v<MapTy>)
+                other.clear();
         }
 
-        // Initilizes the map with a certain size. Map is unchanged on bad_alloc()
-        void initilize(size_type capacity) {
-            // +1 is for the differantiation of the end() iterator
-            bucket_type* new_bucket = m_allocator.allocate(capacity + 1);
-            if (new_bucket == nullptr)
-                throw new std::bad_alloc();
-
-            m_dec_capacity = capacity - 1;
-            m_max_elems = size_type(float(capacity) * M_LOAD_FACTOR);
-            m_size = 0;
-
-            m_bucket = new_bucket;
-            m_bucket_end = m_bucket + capacity;
-            for (bucket_type* iter = m_bucket; iter != m_bucket_end; ++iter)
-                iter->id = uint8_t(-1);
-                
-            //Element at the end must have a non -1u info value
-            m_bucket_end->id = uint8_t(0);
+        // Exchanges bucket arrays with other. Both maps keep their load and growth factors
+        void swapBuckets(unordered_map& other) noexcept {
+            m_table.swap(other.m_table);
+            m_max_elems = maxElems();
+            other.m_max_elems = other.maxElems();
         }
 
-        // Returns the wanted capacity factoring for M_LOAD_FACTOR
-        inline size_type loadedCapacity(size_type capacity) noexcept {
-            return size_type(std::ceil(float(capacity) / M_LOAD_FACTOR));
+        // Calls fn on the elements in the buckets [first, last)
+        template <class Fn>
+        void forEachIn(size_type first, size_type last, Fn& fn) const {
+            m_table.forEachIn(first, last, [&fn](bucket_type& bucket) { fn(reinterpret_cast<reference>(bucket.key_value_pair)); });
         }
 
-        // Returns the first equal or bigger power of two. The return value is always greater than 1
-        static size_type closestPowerOfTwo(size_type num) noexcept {
-            if (num <= 2)
-                return 2u;
+        // Since m_dec_capacity is always a power of two - 1, it's  value is all ones binary
+        // It can be used for fast trimming of the top bits of the hash, since % is a slow operation
+        // Hashers that pick fibonacci_reduction instead keep the top bits of the multiplied hash
+        template <class KeyTy>
+        inline size_type hashAndTrim(KeyTy&& key) const noexcept { return trim(m_hasher(std::forward<KeyTy>(key))); }
 
-            num--;
-            num |= num >> 1;
-            num |= num >> 2;
-            num |= num >> 4;
-            num |= num >> 8;
-            num |= num >> 16;
-            num++;
+        inline size_type trim(size_t hash) const noexcept { return m_reduction::index(hash, m_table.dec_capacity(), m_table.hash_shift()); }
 
-            return num;
+        void growTo(size_type new_capacity) {
+            JVN_STATS(auto grow_start = std::chrono::steady_clock::now();)
+            // Not recorded as insertions in the statistics
+            m_table.rehash(new_capacity, [this](const bucket_type& bucket) { return hashAndTrim(bucket.key_value_pair.first); });
+            m_max_elems = maxElems();
+
+            JVN_STATS(
+                ++m_stats.grow_count;
+                m_stats.grow_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - grow_start);
+            )
         }
+
+        // The number of elements that triggers growth at the current capacity
+        inline size_type maxElems() const noexcept { return size_type(float(m_table.capacity()) * M_LOAD_FACTOR); }
     };
 
 } // namespace jvn
@@ -2,6 +2,9 @@
 #define JVN_ROBIN_HOOD_MEMORY_
 
 #include <cstdlib>
+#include <cstddef>
+#include <memory>
+#include <new>
 
 namespace jvn
 {
@@ -24,7 +27,7 @@ namespace jvn
             :Capacity(capacity),
             m_alloc_left(true)                              
         {
-            m_data = static_cast<pointer>(_aligned_malloc(Capacity * sizeof(*m_data), alignof(*m_data)));
+            m_data = static_cast<pointer>(::operator new(Capacity * sizeof(value_type), std::align_val_t(alignof(value_type)), std::nothrow));
             if (!m_data)
                 throw std::bad_alloc();
             m_left = m_data;
@@ -32,7 +35,7 @@ namespace jvn
         }
 
         ~AlternatingFixedMemoryAllocator() {
-            _aligned_free(static_cast<void*>(m_data));
+            ::operator delete(static_cast<void*>(m_data), std::align_val_t(alignof(value_type)));
         }
         
         AlternatingFixedMemoryAllocator(const AlternatingFixedMemoryAllocator&) = delete;
@@ -72,6 +75,91 @@ namespace jvn
     };
 
 
+    // Byte counts shared by all the CountingAllocator's pointing to it
+    struct AllocationCounter {
+        size_t live_bytes   = 0;
+        size_t peak_bytes   = 0;
+        size_t allocations  = 0;
+
+        void reset() noexcept { *this = AllocationCounter(); }
+
+        static AllocationCounter& global() noexcept {
+            static AllocationCounter counter;
+            return counter;
+        }
+    };
+
+    // Wraps Alloc and counts the bytes it currently holds and the most it held at once
+    // Default constructed allocators share AllocationCounter::global()
+    template<typename Ty, typename Alloc = std::allocator<Ty>>
+    class CountingAllocator {
+    public:
+        using value_type = Ty;
+        using pointer = value_type*;
+        using const_pointer = const value_type*;
+        using reference = value_type&;
+        using const_reference = const value_type&;
+        using difference_type = std::ptrdiff_t;
+        using size_type = std::size_t;
+
+        template<typename Uy>
+        struct rebind {
+            using other = CountingAllocator<Uy, typename std::allocator_traits<Alloc>::template rebind_alloc<Uy>>;
+        };
+
+        CountingAllocator() noexcept
+            :m_counter(&AllocationCounter::global()) {}
+
+        explicit CountingAllocator(AllocationCounter* counter, Alloc allocator = Alloc()) noexcept
+            :m_allocator(allocator),
+            m_counter(counter) {}
+
+        template<typename Uy, typename OtherAlloc>
+        CountingAllocator(const CountingAllocator<Uy, OtherAlloc>& other) noexcept
+            :m_allocator(other.m_allocator),
+            m_counter(other.m_counter) {}
+
+        pointer allocate(size_type n) {
+            pointer ptr = m_allocator.allocate(n);
+            m_counter->live_bytes += n * sizeof(value_type);
+            if (m_counter->live_bytes > m_counter->peak_bytes)
+                m_counter->peak_bytes = m_counter->live_bytes;
+            ++m_counter->allocations;
+            return ptr;
+        }
+
+        void deallocate(pointer ptr, size_type n) {
+            if (ptr == nullptr)
+                return;
+
+            m_allocator.deallocate(ptr, n);
+            m_counter->live_bytes -= n * sizeof(value_type);
+        }
+
+        const AllocationCounter& counter() const noexcept { return *m_counter; }
+        // The wrapped allocator
+        const Alloc& base() const noexcept { return m_allocator; }
+
+    private:
+        template<typename, typename>
+        friend class CountingAllocator;
+
+        Alloc m_allocator;
+        AllocationCounter* m_counter;
+    };
+
+    // Equal if they count into the same counter and the wrapped allocators are equal, across rebinds too
+    template<typename Ty, typename Alloc, typename Uy, typename OtherAlloc>
+    bool operator==(const CountingAllocator<Ty, Alloc>& lhs, const CountingAllocator<Uy, OtherAlloc>& rhs) noexcept {
+        return &lhs.counter() == &rhs.counter() && lhs.base() == rhs.base();
+    }
+
+    template<typename Ty, typename Alloc, typename Uy, typename OtherAlloc>
+    bool operator!=(const CountingAllocator<Ty, Alloc>& lhs, const CountingAllocator<Uy, OtherAlloc>& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+
 } // namespace jvn
 
 
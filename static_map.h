@@ -0,0 +1,134 @@
+#ifndef JVN_ROBIN_HOOD_STATIC_MAP_
+#define JVN_ROBIN_HOOD_STATIC_MAP_
+
+#include "hash.h"
+#include "table.h"
+#include <utility>
+#include <functional>
+#include <stdexcept>
+
+namespace jvn
+{
+
+    // An immutable Robin Hood map over a fixed set of keys that can be built in a constant expression,
+    // in which case the placement is done at compile time and there is nothing to do at startup.
+    // Kt and Vt have to be literal and default constructible types, and Hasher has to be constexpr
+    template <class Kt, class Vt, size_t N,
+            class Hasher = constexpr_hash<Kt>,
+            class KeyEq = std::equal_to<Kt>>
+        class static_map
+    {
+    public:
+        using hasher                = Hasher;
+        using key_equal             = KeyEq;
+        using size_type             = size_t;
+        using key_type              = Kt;
+        using mapped_type           = Vt;
+        using value_type            = std::pair<key_type, mapped_type>;
+
+        // Keeps the load under 0.8 and leaves at least one empty bucket
+        static constexpr size_type CAPACITY = detail::closestPowerOfTwo(N + N / 4 + 1);
+    private:
+        using m_reduction           = typename hash_reduction<hasher>::type;
+        static constexpr uint8_t M_HASH_SHIFT = detail::hashShift(CAPACITY);
+    public:
+
+        // Fails to compile in a constant expression if a key is duplicated
+        constexpr static_map(const value_type (&elements)[N]) {
+            for (size_type i = 0; i < CAPACITY; ++i)
+                m_ids[i] = uint8_t(-1);
+
+            for (size_type i = 0; i < N; ++i)
+                place(elements[i].first, elements[i].second);
+
+            for (size_type i = 0; i < CAPACITY; ++i)
+                if (m_ids[i] != uint8_t(-1) && m_ids[i] > m_max_id)
+                    m_max_id = m_ids[i];
+        }
+
+        // Returns a pointer to the mapped value or nullptr if the key isn't present.
+        // Probes at most the longest hash distance in the map, so short maps unroll well
+        constexpr const mapped_type* find(const key_type& key) const noexcept {
+            size_type pos = m_reduction::index(hasher()(key), CAPACITY - 1, M_HASH_SHIFT);
+            for (uint8_t id = 0; id <= m_max_id; ++id) {
+                // Key found
+                if (m_ids[pos] == id && key_equal()(m_keys[pos], key))
+                    return &m_values[pos];
+
+                // Key not found
+                if (m_ids[pos] == uint8_t(-1) || m_ids[pos] < id)
+                    return nullptr;
+
+                pos = (pos + 1) & (CAPACITY - 1);
+            }
+
+            return nullptr;
+        }
+
+        constexpr bool contains(const key_type& key) const noexcept { return find(key) != nullptr; }
+
+        constexpr const mapped_type& at(const key_type& key) const {
+            const mapped_type* value = find(key);
+            if (value == nullptr)
+                throw std::out_of_range("jvn::static_map::at: key not found");
+
+            return *value;
+        }
+
+        constexpr size_type size() const noexcept { return N; }
+        constexpr bool empty() const noexcept { return N == 0; }
+
+    private:
+        key_type m_keys[CAPACITY]       = {};
+        mapped_type m_values[CAPACITY]  = {};
+        // Distance from ideal hash position
+        uint8_t m_ids[CAPACITY]         = {};
+        // The longest distance from ideal hash position
+        uint8_t m_max_id                = 0;
+
+        // Robin Hood insertion, elements are swapped member by member since
+        // std::pair and std::swap can't be assigned in constant expressions before C++20
+        constexpr void place(key_type key, mapped_type value) {
+            uint8_t id = 0;
+            size_type pos = m_reduction::index(hasher()(key), CAPACITY - 1, M_HASH_SHIFT);
+            while (true) {
+                // Empty slot found
+                if (m_ids[pos] == uint8_t(-1)) {
+                    m_ids[pos] = id;
+                    m_keys[pos] = key;
+                    m_values[pos] = value;
+                    return;
+                }
+
+                // Rich found, carry on inserting the displaced element
+                if (m_ids[pos] < id) {
+                    uint8_t displaced_id = m_ids[pos];
+                    key_type displaced_key = m_keys[pos];
+                    mapped_type displaced_value = m_values[pos];
+
+                    m_ids[pos] = id;
+                    m_keys[pos] = key;
+                    m_values[pos] = value;
+
+                    id = displaced_id;
+                    key = displaced_key;
+                    value = displaced_value;
+                }
+                else if (m_ids[pos] == id && key_equal()(m_keys[pos], key))
+                    throw std::invalid_argument("jvn::static_map: duplicate key");
+
+                ++id;
+                pos = (pos + 1) & (CAPACITY - 1);
+            }
+        }
+    };
+
+    // Deduces the number of elements, e.g. make_static_map<std::string_view, int>({{"one", 1}, {"two", 2}})
+    template <class Kt, class Vt, class Hasher = constexpr_hash<Kt>, class KeyEq = std::equal_to<Kt>, size_t N>
+    constexpr static_map<Kt, Vt, N, Hasher, KeyEq> make_static_map(const std::pair<Kt, Vt> (&elements)[N]) {
+        return static_map<Kt, Vt, N, Hasher, KeyEq>(elements);
+    }
+
+} // namespace jvn
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef JVN_ROBIN_HOOD_STATS_
+#define JVN_ROBIN_HOOD_STATS_
+
+#include "utility.h"
+#include <cstddef>
+#include <chrono>
+
+namespace jvn
+{
+
+    // Linear histogram of small non-negative values
+    // Values that don't fit are accumulated in the last slot
+    struct histogram {
+        static constexpr size_t SIZE = 32;
+
+        size_t count[SIZE] = {};
+        size_t max = 0;
+
+        inline void record(size_t value) noexcept {
+            ++count[value < SIZE ? value : SIZE - 1];
+            if (value > max)
+                max = value;
+        }
+
+        size_t total() const noexcept {
+            size_t sum = 0;
+            for (size_t i = 0; i < SIZE; ++i)
+                sum += count[i];
+            return sum;
+        }
+
+        // Mean of the recorded values, overflowed values are counted as SIZE - 1
+        double mean() const noexcept {
+            size_t sum = 0, num = 0;
+            for (size_t i = 0; i < SIZE; ++i) {
+                sum += i * count[i];
+                num += count[i];
+            }
+            return num ? double(sum) / double(num) : 0.0;
+        }
+    };
+
+    // Counters collected by the map while it's running
+    // Only maintained when compiled with JVN_ENABLE_STATS
+    struct map_stats {
+        // Number of probed buckets past the home bucket
+        histogram find_hit;
+        histogram find_miss;
+        // Distance from the home bucket a newly inserted element lands on
+        histogram insert_displacement;
+        // Number of elements shifted back by an erase
+        histogram erase_shift;
+
+        // Number of elements moved forward by insertions of richer elements
+        size_t insert_swaps = 0;
+
+        size_t grow_count = 0;
+        std::chrono::nanoseconds grow_time{0};
+    };
+
+    // Snapshot of the bucket array produced on demand by unordered_map::analyze()
+    struct map_analysis {
+        size_t size = 0;
+        size_t bucket_count = 0;
+        float load_factor = 0.0f;
+
+        // Current distance of each element from its home bucket
+        histogram displacement;
+        // Lengths of the runs of consecutive occupied buckets
+        histogram cluster_length;
+        size_t cluster_count = 0;
+    };
+
+} // namespace jvn
+
+#endif
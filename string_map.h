@@ -0,0 +1,463 @@
+#ifndef JVN_ROBIN_HOOD_STRING_MAP_
+#define JVN_ROBIN_HOOD_STRING_MAP_
+
+#include "hash.h"
+#include "table.h"
+#include <utility>
+#include <tuple>
+#include <memory>
+#include <vector>
+#include <string_view>
+#include <cstring>
+#include <stdexcept>
+
+namespace jvn
+{
+    // Location of an interned key in the arena of a string_map
+    struct string_key {
+        const char* data;
+        uint32_t length;
+        // Top bits of the key's hash, compared before the key bytes
+        uint32_t fragment;
+    };
+
+    JVN_PRAGMA_PACK_PUSH(1)
+    template <class Vt>
+    struct string_bucket {
+        string_key key;
+        // Distance from ideal hash position
+        uint8_t id;
+        Vt value;
+    };
+    JVN_PRAGMA_PACK_POP()
+
+namespace detail
+{
+    // Append-only storage for the keys of a string_map. Bytes are placed in fixed size chunks
+    // that are never reallocated, so an interned key keeps its address until the arena is cleared
+    template <class Alloc>
+    class string_arena
+    {
+    public:
+        using allocator_type        = typename std::allocator_traits<Alloc>::template rebind_alloc<char>;
+        using size_type             = size_t;
+
+        // Keys longer than a chunk get a chunk of their own
+        static constexpr size_type CHUNK_SIZE = 4096;
+
+        explicit string_arena(const allocator_type& allocator = allocator_type())
+            :m_allocator(allocator),
+            m_chunks(allocator) {}
+
+        string_arena(string_arena&& a) noexcept
+            :m_allocator(std::move(a.m_allocator)),
+            m_chunks(std::move(a.m_chunks)),
+            m_chunk(std::exchange(a.m_chunk, nullptr)),
+            m_chunk_used(std::exchange(a.m_chunk_used, 0)),
+            m_chunk_size(std::exchange(a.m_chunk_size, 0)),
+            m_size(std::exchange(a.m_size, 0)),
+            m_capacity(std::exchange(a.m_capacity, 0)) {}
+
+        string_arena(const string_arena&)               = delete;
+        string_arena& operator=(const string_arena&)    = delete;
+        string_arena& operator=(string_arena&&)         = delete;
+
+        ~string_arena() { clear(); }
+
+        inline allocator_type get_allocator() const { return m_allocator; }
+
+        // Bytes appended, including the ones of erased keys
+        inline size_type size() const noexcept { return m_size; }
+        // Bytes held by the chunks
+        inline size_type capacity() const noexcept { return m_capacity + m_chunks.capacity() * sizeof(chunk); }
+
+        // Makes sure the next count bytes are appended without allocating
+        void reserve(size_type count) {
+            if (count > m_chunk_size - m_chunk_used)
+                addChunk(count);
+        }
+
+        // Copies count bytes into the arena and returns their address there
+        const char* append(const char* bytes, size_type count) {
+            reserve(count);
+
+            char* dest = m_chunk + m_chunk_used;
+            if (count)
+                std::memcpy(dest, bytes, count);
+            m_chunk_used += count;
+            m_size += count;
+            return dest;
+        }
+
+        // Takes back the bytes appended last, bytes has to be the address append() returned
+        void pop(const char* bytes) noexcept {
+            size_type count = size_type(m_chunk + m_chunk_used - bytes);
+            m_chunk_used -= count;
+            m_size -= count;
+        }
+
+        void clear() noexcept {
+            for (chunk& c : m_chunks)
+                m_allocator.deallocate(c.bytes, c.size);
+
+            m_chunks.clear();
+            m_chunk = nullptr;
+            m_chunk_used = m_chunk_size = m_size = m_capacity = 0;
+        }
+
+        void swap(string_arena& a) noexcept {
+            using std::swap;
+            swap(m_chunks, a.m_chunks);
+            swap(m_chunk, a.m_chunk);
+            swap(m_chunk_used, a.m_chunk_used);
+            swap(m_chunk_size, a.m_chunk_size);
+            swap(m_size, a.m_size);
+            swap(m_capacity, a.m_capacity);
+        }
+
+    private:
+        struct chunk {
+            char* bytes;
+            size_type size;
+        };
+
+        allocator_type m_allocator;
+        std::vector<chunk, typename std::allocator_traits<Alloc>::template rebind_alloc<chunk>> m_chunks;
+
+        // The chunk being appended to
+        char* m_chunk               = nullptr;
+        size_type m_chunk_used      = 0;
+        size_type m_chunk_size      = 0;
+
+        size_type m_size            = 0;
+        size_type m_capacity        = 0;
+
+        // The rest of the current chunk is left unused
+        void addChunk(size_type count) {
+            size_type size = count > CHUNK_SIZE ? count : CHUNK_SIZE;
+            char* bytes = m_allocator.allocate(size);
+            if (bytes == nullptr)
+                throw std::bad_alloc();
+
+            try {
+                m_chunks.push_back(chunk{bytes, size});
+            }
+            catch (...) {
+                m_allocator.deallocate(bytes, size);
+                throw;
+            }
+
+            m_chunk = bytes;
+            m_chunk_used = 0;
+            m_chunk_size = size;
+            m_capacity += size;
+        }
+    };
+
+    // The key is only a position in the arena, so it's copied as is
+    template <class Vt>
+    struct bucket_traits<string_bucket<Vt>> {
+        using bucket_type = string_bucket<Vt>;
+
+        static void move_construct(bucket_type& dest, bucket_type& src) {
+            dest.key = src.key;
+            ::new (&(dest.value)) Vt(std::move(src.value));
+        }
+
+        static void copy_construct(bucket_type& dest, const bucket_type& src) {
+            dest.key = src.key;
+            ::new (&(dest.value)) Vt(src.value);
+        }
+
+        static void swap(bucket_type& lhs, bucket_type& rhs) {
+            using std::swap;
+            std::swap(lhs.key, rhs.key);
+            swap(lhs.value, rhs.value);
+        }
+
+        static void destroy(bucket_type& bucket) noexcept { bucket.value.~Vt(); }
+    };
+} // namespace detail
+
+    // A Robin Hood map with string keys interned into an append-only arena owned by the map.
+    // Buckets only hold the position of the key in the arena, so there are no per-key allocations
+    // and Robin Hood swaps never move strings. The arena is never reallocated, so keys returned
+    // by find() and the iterators stay valid across insertions. Erased keys are reclaimed by compact()
+    template <class Vt,
+            class Hasher = hash<std::string_view>,
+            class Alloc = std::allocator<string_bucket<Vt>>>
+        class string_map
+    {
+    public:
+        using hasher                = Hasher;
+        using allocator_type        = Alloc;
+        using size_type             = typename Alloc::size_type;
+        using difference_type       = typename Alloc::difference_type;
+        using key_type              = std::string_view;
+        using mapped_type           = Vt;
+        using value_type            = std::pair<key_type, mapped_type&>;
+        using reference             = value_type;
+
+        using bucket_type           = string_bucket<mapped_type>;
+    private:
+        using m_reduction           = typename hash_reduction<hasher>::type;
+        using m_arena_type          = detail::string_arena<Alloc>;
+        using m_table_type          = detail::robin_hood_table<bucket_type, allocator_type>;
+    public:
+
+        class Iter
+        {
+        public:
+            // Keeps the key-value pair alive for operator->
+            struct pointer {
+                value_type key_value_pair;
+                inline value_type* operator->() noexcept { return &key_value_pair; }
+            };
+
+            Iter(const Iter&)               = default;
+            ~Iter()                         = default;
+            Iter& operator=(const Iter&)    = default;
+
+            inline friend constexpr bool operator==(const Iter& lhs, const Iter& rhs) noexcept { return lhs.m_bucket_ptr == rhs.m_bucket_ptr; }
+            inline friend constexpr bool operator!=(const Iter& lhs, const Iter& rhs) noexcept { return !(lhs == rhs); }
+            inline Iter& operator++() {
+                while ((++m_bucket_ptr)->id == uint8_t(-1));
+                return *this;
+            }
+            inline key_type key() const noexcept { return m_map->keyOf(m_bucket_ptr->key); }
+            inline mapped_type& value() const noexcept { return m_bucket_ptr->value; }
+            inline pointer operator->() const { return pointer{operator*()}; }
+            inline reference operator*() const { return reference(key(), value()); }
+        private:
+            friend class string_map;
+            const string_map* m_map;
+            bucket_type* m_bucket_ptr;
+
+            Iter(const string_map* map, bucket_type* bucket_ptr): m_map(map), m_bucket_ptr(bucket_ptr)
+            {
+                if (m_bucket_ptr->id == uint8_t(-1))
+                    operator++();
+            }
+        };
+
+        friend class Iter;
+        using iterator              = Iter;
+
+        string_map()
+            :m_table(16),
+            m_max_elems(maxElems()) {}
+
+        string_map(size_type inital_capacity, float load_factor = 0.8f, size_type growth_factor = 2, allocator_type allocator = allocator_type())
+            :M_LOAD_FACTOR(load_factor),
+            M_GROWTH_FACTOR(detail::closestPowerOfTwo(growth_factor)),
+            m_arena(allocator),
+            m_table(detail::closestPowerOfTwo(inital_capacity), allocator),
+            m_max_elems(maxElems()) {}
+
+        // Only the live keys are copied, so the copy starts compacted
+        string_map(const string_map& m)
+            :M_LOAD_FACTOR(m.M_LOAD_FACTOR),
+            M_GROWTH_FACTOR(m.M_GROWTH_FACTOR),
+            m_hasher(m.m_hasher),
+            m_arena(m.m_arena.get_allocator()),
+            m_table(m.m_table),
+            m_max_elems(m.m_max_elems) {
+            // The copied buckets still point into the arena of m
+            m_arena.reserve(m.m_arena.size() - m.m_dead_bytes);
+            for (bucket_type* iter = m_table.begin(); iter != m_table.end(); ++iter)
+                if (iter->id != uint8_t(-1))
+                    iter->key.data = m_arena.append(iter->key.data, iter->key.length);
+        }
+
+        string_map(string_map&& m)
+            :M_LOAD_FACTOR(m.M_LOAD_FACTOR),
+            M_GROWTH_FACTOR(m.M_GROWTH_FACTOR),
+            m_hasher(std::move(m.m_hasher)),
+            m_arena(std::move(m.m_arena)),
+            m_dead_bytes(m.m_dead_bytes),
+            m_table(std::move(m.m_table)),
+            m_max_elems(m.m_max_elems) {}
+
+        void reserve(size_type size) {
+            size = detail::loadedCapacity(size, M_LOAD_FACTOR);
+            if (size > m_table.dec_capacity())
+                growTo(detail::closestPowerOfTwo(size));
+        }
+
+        inline mapped_type& operator[](key_type key) {
+            return try_emplace(key).first.value();
+        }
+
+        // Constructs the mapped value from args only if the key isn't present
+        template <class... Args>
+        std::pair<iterator, bool> try_emplace(key_type key, Args&&... args) {
+            auto [iter, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(iter, std::forward<Args>(args)...);
+
+            return std::pair<iterator, bool>(iterator(this, iter), claimed);
+        }
+
+        template <class MappedTy>
+        std::pair<iterator, bool> insert_or_assign(key_type key, MappedTy&& obj) {
+            auto [iter, claimed] = claimBucket(key);
+            if (claimed)
+                constructAt(iter, std::forward<MappedTy>(obj));
+            else
+                iter->value = std::forward<MappedTy>(obj);
+
+            return std::pair<iterator, bool>(iterator(this, iter), claimed);
+        }
+
+        // The key bytes stay in the arena until compact() or clear()
+        size_type erase(key_type key) noexcept {
+            bucket_type* iter = find(key).m_bucket_ptr;
+            if (iter == m_table.end())
+                return size_type(0);
+
+            m_dead_bytes += iter->key.length;
+            m_table.erase(iter);
+            return size_type(1);
+        }
+
+        // Compares the hash fragment and the length before touching the key bytes
+        iterator find(key_type key) const noexcept {
+            size_t hash = m_hasher(key);
+            bucket_type* bucket = m_table.find(trim(hash), matching(key, hashFragment(hash))).first;
+            if (JVN_UNLIKELY(bucket == nullptr))
+                return end();
+
+            return iterator(this, bucket);
+        }
+
+        inline bool contains(key_type key) const noexcept { return find(key) != end(); }
+
+        void clear() noexcept {
+            m_table.clear();
+            m_arena.clear();
+            m_dead_bytes = 0;
+        }
+
+        // Rebuilds the arena without the bytes of erased keys. Invalidates the
+        // keys previously returned by find() and the iterators
+        void compact() {
+            m_arena_type arena(m_arena.get_allocator());
+            // Appending can't throw after this, so no bucket is left pointing into a freed arena
+            arena.reserve(m_arena.size() - m_dead_bytes);
+            for (bucket_type* iter = m_table.begin(); iter != m_table.end(); ++iter)
+                if (iter->id != uint8_t(-1))
+                    iter->key.data = arena.append(iter->key.data, iter->key.length);
+
+            m_arena.swap(arena);
+            m_dead_bytes = 0;
+        }
+
+        inline size_type size() const noexcept { return m_table.size(); }
+        inline bool empty() const noexcept { return !m_table.size(); }
+
+        inline size_type bucket_count() const noexcept { return m_table.capacity(); }
+        inline float load_factor() const noexcept { return float(m_table.size()) / float(m_table.capacity()); }
+        // Bytes of key data in the arena, including erased keys not yet compacted
+        inline size_type arena_size() const noexcept { return m_arena.size(); }
+
+        // Bytes held by the map itself, including the arena. Doesn't
+        // include memory the values allocate on their own
+        inline size_type memory_usage() const noexcept {
+            return sizeof(*this) + m_arena.capacity() + m_table.memory_usage();
+        }
+
+        inline iterator begin() const noexcept { return iterator(this, m_table.begin()); }
+        inline iterator end() const noexcept { return iterator(this, m_table.end()); }
+
+    private:
+        float M_LOAD_FACTOR         = 0.8f;
+        size_type M_GROWTH_FACTOR   = 2;
+
+        hasher m_hasher;
+
+        m_arena_type m_arena;
+        // Bytes of erased keys still in the arena
+        size_type m_dead_bytes      = 0;
+
+        m_table_type m_table;
+        // The number of elements that triggers growth
+        size_type m_max_elems       = 0;
+
+        inline key_type keyOf(const string_key& key) const noexcept {
+            return key_type(key.data, key.length);
+        }
+
+        inline bool keyEquals(const string_key& lhs, uint32_t fragment, key_type rhs) const noexcept {
+            // The data of empty keys can be null
+            return lhs.fragment == fragment && lhs.length == rhs.size() &&
+                    (rhs.empty() || std::memcmp(lhs.data, rhs.data(), rhs.size()) == 0);
+        }
+
+        static inline uint32_t hashFragment(size_t hash) noexcept {
+            return uint32_t(hash >> (JVN(BITNESS) - 32));
+        }
+
+        // Returns the bucket holding the key, or claims a bucket for it by displacing richer elements and
+        // interns the key. A claimed bucket's value is left unconstructed and the caller must construct it
+        // with constructAt(). The map only grows when a bucket is claimed
+        std::pair<bucket_type*, bool> claimBucket(key_type key) {
+            // The length is kept in 32 bits
+            if (JVN_UNLIKELY(key.size() > UINT32_MAX))
+                throw std::length_error("jvn::string_map: key is too long");
+
+            size_t hash = m_hasher(key);
+            uint32_t fragment = hashFragment(hash);
+
+            if (JVN_UNLIKELY(m_table.size() == m_max_elems)) {
+                if (bucket_type* bucket = m_table.find(trim(hash), matching(key, fragment)).first)
+                    return std::pair<bucket_type*, bool>(bucket, false);
+
+                growTo(m_table.capacity() * M_GROWTH_FACTOR);
+            }
+
+            auto result = m_table.claim(trim(hash), matching(key, fragment));
+            if (result.claimed) {
+                try {
+                    result.bucket->key = string_key{m_arena.append(key.data(), key.size()), uint32_t(key.size()), fragment};
+                }
+                catch (...) {
+                    m_table.release(result.bucket);
+                    throw;
+                }
+            }
+
+            return std::pair<bucket_type*, bool>(result.bucket, result.claimed);
+        }
+
+        // Gives the bucket back if the construction throws, along with the key bytes interned last
+        template <class... Args>
+        void constructAt(bucket_type* bucket, Args&&... args) {
+            try {
+                ::new (&(bucket->value)) mapped_type(std::forward<Args>(args)...);
+            }
+            catch (...) {
+                m_arena.pop(bucket->key.data);
+                m_table.release(bucket);
+                throw;
+            }
+        }
+
+        inline auto matching(key_type key, uint32_t fragment) const noexcept {
+            return [this, key, fragment](const bucket_type& bucket) { return keyEquals(bucket.key, fragment, key); };
+        }
+
+        inline size_type trim(size_t hash) const noexcept { return m_reduction::index(hash, m_table.dec_capacity(), m_table.hash_shift()); }
+
+        // The keys are rehashed from the arena, the fragment only holds the top bits
+        void growTo(size_type new_capacity) {
+            m_table.rehash(new_capacity, [this](const bucket_type& bucket) { return trim(m_hasher(keyOf(bucket.key))); });
+            m_max_elems = maxElems();
+        }
+
+        // The number of elements that triggers growth at the current capacity
+        inline size_type maxElems() const noexcept { return size_type(float(m_table.capacity()) * M_LOAD_FACTOR); }
+    };
+
+} // namespace jvn
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef JVN_ROBIN_HOOD_TABLE_
+#define JVN_ROBIN_HOOD_TABLE_
+
+#include "utility.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <new>
+#include <cmath>
+#include <cstring>
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
+
+namespace jvn
+{
+
+namespace detail
+{
+    // Returns the first equal or bigger power of two. The return value is always greater than 1
+    constexpr size_t closestPowerOfTwo(size_t num) noexcept {
+        size_t power = 2;
+        while (power < num)
+            power <<= 1;
+
+        return power;
+    }
+
+    // Bitness - log2(capacity) for a power of two capacity, used by hash reductions keeping the top bits
+    constexpr uint8_t hashShift(size_t capacity) noexcept {
+        uint8_t shift = JVN(BITNESS);
+        for (; capacity > 1; capacity >>= 1)
+            --shift;
+
+        return shift;
+    }
+
+    // Returns the capacity needed to hold size elements under load_factor
+    inline size_t loadedCapacity(size_t size, float load_factor) noexcept {
+        return size_t(std::ceil(float(size) / load_factor));
+    }
+
+    // Index of the lowest set bit, bits can't be 0
+    inline unsigned countTrailingZeros(uint64_t bits) noexcept {
+#if defined(_MSC_VER) && defined(_M_X64)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return unsigned(index);
+#elif defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanForward(&index, uint32_t(bits)))
+            return unsigned(index);
+        _BitScanForward(&index, uint32_t(bits >> 32));
+        return unsigned(index) + 32;
+#else
+        return unsigned(__builtin_ctzll(bits));
+#endif
+    }
+
+    // Moves the element of a bucket type around, specialized next to each bucket. Has to provide
+    // move_construct(dest, src), swap(lhs, rhs), destroy(bucket), and copy_construct(dest, src)
+    // if the table gets copied. None of them touch the id
+    template <class Bucket>
+    struct bucket_traits;
+
+    // The Robin Hood bucket array shared by the containers, which do the hashing and the key comparisons.
+    // Buckets hold a uint8_t id, the distance from the ideal hash position, or -1 when empty.
+    // There is one extra bucket past the end with a non -1 id, so iterators stop at end().
+    // With JVN_ENABLE_OCCUPANCY_BITMAP a bitmap with a bit per occupied bucket lets forEachIn()
+    // skip empty buckets 64 at a time, for a bitmap write on every insertion and erase
+    template <class Bucket, class Alloc>
+    class robin_hood_table
+    {
+    public:
+        using bucket_type           = Bucket;
+        using allocator_type        = Alloc;
+        using size_type             = typename Alloc::size_type;
+        using traits                = bucket_traits<bucket_type>;
+    private:
+        using m_word_allocator      = typename std::allocator_traits<Alloc>::template rebind_alloc<uint64_t>;
+        static constexpr bool M_OCCUPANCY_BITMAP = JVN(OCCUPANCY_BITMAP);
+    public:
+
+        struct claim_result {
+            bucket_type* bucket;
+            // False if a matching element was found instead
+            bool claimed;
+            // Distance from the home bucket
+            uint8_t distance;
+            // Number of elements moved forward to make room
+            size_type shifted;
+        };
+
+        // capacity has to be a power of two
+        explicit robin_hood_table(size_type capacity, allocator_type allocator = allocator_type())
+            :m_allocator(allocator) {
+            initilize(capacity);
+        }
+
+        robin_hood_table(const robin_hood_table& t)
+            :m_allocator(t.m_allocator) {
+            initilize(t.capacity());
+
+            try {
+                for (bucket_type *iter = m_bucket, *other_iter = t.m_bucket; iter != m_bucket_end; ++iter, ++other_iter)
+                    if (other_iter->id != uint8_t(-1)) {
+                        traits::copy_construct(*iter, *other_iter);
+                        iter->id = other_iter->id;
+                        markOccupied(iter);
+                        ++m_size;
+                    }
+            }
+            catch (...) {
+                clear();
+                deallocate();
+                throw;
+            }
+        }
+
+        robin_hood_table(robin_hood_table&& t) noexcept
+            :m_allocator(std::move(t.m_allocator)),
+            m_bucket(std::exchange(t.m_bucket, nullptr)),
+            m_bucket_end(std::exchange(t.m_bucket_end, nullptr)),
+            m_occupied(std::exchange(t.m_occupied, nullptr)),
+            m_dec_capacity(t.m_dec_capacity),
+            m_hash_shift(t.m_hash_shift),
+            m_size(std::exchange(t.m_size, 0)) {}
+
+        robin_hood_table& operator=(const robin_hood_table&)    = delete;
+        robin_hood_table& operator=(robin_hood_table&&)         = delete;
+
+        ~robin_hood_table() {
+            clear();
+            deallocate();
+        }
+
+        inline bucket_type* begin() const noexcept { return m_bucket; }
+        inline bucket_type* end() const noexcept { return m_bucket_end; }
+
+        inline size_type size() const noexcept { return m_size; }
+        inline size_type capacity() const noexcept { return m_dec_capacity + 1; }
+        inline size_type dec_capacity() const noexcept { return m_dec_capacity; }
+        // Bitness - log2(capacity), used by hash reductions keeping the top bits
+        inline uint8_t hash_shift() const noexcept { return m_hash_shift; }
+        // Bytes held by the bucket array, including the end() bucket, and the occupancy bitmap if any
+        inline size_type memory_usage() const noexcept {
+            return m_bucket ? (m_dec_capacity + 2) * sizeof(bucket_type) + wordCount(capacity()) * sizeof(uint64_t) : 0;
+        }
+
+        inline bucket_type* advance(bucket_type* iter) const noexcept {
+            if (JVN_UNLIKELY(++iter == m_bucket_end))
+                    return m_bucket;
+
+            return iter;
+        }
+
+        // Returns the bucket starting from home for which match(const bucket_type&) is true, or nullptr.
+        // Also returns how far the probe went
+        template <class Match>
+        std::pair<bucket_type*, uint8_t> find(size_type home, Match&& match) const {
+            uint8_t id = 0;
+            bucket_type* iter = m_bucket + home;
+            while (true) {
+                // Key found
+                if (iter->id == id && match(*iter))
+                    return std::pair<bucket_type*, uint8_t>(iter, id);
+
+                // Key not found
+                if (JVN_UNLIKELY(iter->id == uint8_t(-1) || iter->id < id))
+                    return std::pair<bucket_type*, uint8_t>(nullptr, id);
+
+                ++id;
+                iter = advance(iter);
+            }
+        }
+
+        // Returns the bucket for which match(const bucket_type&) is true, or claims one at the first richer
+        // element, moving the rest of the cluster forward. A claimed bucket is left unconstructed and
+        // the caller must either construct the element in it or give it back with release().
+        // There has to be at least one empty bucket
+        template <class Match>
+        claim_result claim(size_type home, Match&& match) {
+            uint8_t id = 0;
+            size_type shifted = 0;
+            bucket_type* iter = m_bucket + home;
+            while (true) {
+                // Empty slot found
+                if (iter->id == uint8_t(-1))
+                    break;
+
+                // Rich found
+                if (iter->id < id) {
+                    shifted = shiftForward(iter);
+                    break;
+                }
+
+                // Key found
+                if (JVN_UNLIKELY(iter->id == id && match(*iter)))
+                    return claim_result{iter, false, id, 0};
+
+                ++id;
+                iter = advance(iter);
+            }
+
+            iter->id = id;
+            if (!shifted)
+                markOccupied(iter);
+            ++m_size;
+            return claim_result{iter, true, id, shifted};
+        }
+
+        // Gives back a claimed bucket whose element couldn't be constructed
+        void release(bucket_type* iter) noexcept {
+            bucket_type* next_iter = advance(iter);
+            if (next_iter->id == uint8_t(0) || next_iter->id == uint8_t(-1)) {
+                iter->id = uint8_t(-1);
+                markEmpty(iter);
+                --m_size;
+                return;
+            }
+
+            // Fill the hole with the next element and erase the moved from one left behind
+            iter->id = next_iter->id - 1;
+            traits::move_construct(*iter, *next_iter);
+            erase(next_iter);
+        }
+
+        // Traverses the cluster and swaps elements with previous until an empty slot
+        // is found or an element with the 0 hash distance. Returns the number of moved elements
+        size_type erase(bucket_type* iter) noexcept {
+            size_type shifted = 0;
+            bucket_type* next_iter = advance(iter);
+            while (next_iter->id != uint8_t(0) && next_iter->id != uint8_t(-1)) {
+                iter->id = next_iter->id - 1;
+                traits::swap(*iter, *next_iter);
+
+                iter = std::exchange(next_iter, advance(next_iter));
+                ++shifted;
+            }
+
+            iter->id = uint8_t(-1);
+            markEmpty(iter);
+            traits::destroy(*iter);
+            --m_size;
+            return shifted;
+        }
+
+        void clear() noexcept {
+            for (bucket_type* iter = m_bucket; iter != m_bucket_end; ++iter)
+                if (iter->id != uint8_t(-1)) {
+                    traits::destroy(*iter);
+                    iter->id = uint8_t(-1);
+                }
+
+            if (m_occupied)
+                std::memset(m_occupied, 0, wordCount(capacity()) * sizeof(uint64_t));
+            m_size = 0;
+        }
+
+        // Calls fn(bucket_type&) on the occupied buckets with an index in [first, last)
+        template <class Fn>
+        void forEachIn(size_type first, size_type last, Fn&& fn) const {
+            if constexpr (M_OCCUPANCY_BITMAP) {
+                if (first >= last)
+                    return;
+
+                size_type word = first / 64;
+                const size_type last_word = (last - 1) / 64;
+                uint64_t bits = m_occupied[word] & (~uint64_t(0) << (first % 64));
+                while (true) {
+                    if (word == last_word)
+                        bits &= ~uint64_t(0) >> (63 - (last - 1) % 64);
+
+                    for (; bits; bits &= bits - 1)
+                        fn(m_bucket[word * 64 + countTrailingZeros(bits)]);
+
+                    if (word == last_word)
+                        return;
+                    bits = m_occupied[++word];
+                }
+            }
+            else {
+                for (bucket_type *iter = m_bucket + first, *last_iter = m_bucket + last; iter != last_iter; ++iter)
+                    if (iter->id != uint8_t(-1))
+                        fn(*iter);
+            }
+        }
+
+        // Moves every element into a new array of capacity buckets. home(const bucket_type&) is called
+        // after the switch, so it trims against the new capacity. The table is unchanged on bad_alloc()
+        template <class HomeFn>
+        void rehash(size_type capacity, HomeFn&& home) {
+            bucket_type* prev_bucket = m_bucket,
+                    *prev_bucket_end = m_bucket_end;
+            uint64_t* prev_occupied = m_occupied;
+            size_type prev_capacity = this->capacity();
+
+            initilize(capacity);
+
+            // Keys are unique, so there's nothing to compare
+            auto no_match = [](const bucket_type&) { return false; };
+            for (bucket_type* iter = prev_bucket; iter != prev_bucket_end; ++iter)
+                if (iter->id != uint8_t(-1)) {
+                    bucket_type* bucket = claim(home(*iter), no_match).bucket;
+                    traits::move_construct(*bucket, *iter);
+                    traits::destroy(*iter);
+                }
+
+            m_allocator.deallocate(prev_bucket, size_type(prev_bucket_end - prev_bucket + 1));
+            if (prev_occupied)
+                m_word_allocator(m_allocator).deallocate(prev_occupied, wordCount(prev_capacity));
+        }
+
+        // Exchanges bucket arrays with t
+        void swap(robin_hood_table& t) noexcept {
+            using std::swap;
+            swap(m_bucket, t.m_bucket);
+            swap(m_bucket_end, t.m_bucket_end);
+            swap(m_occupied, t.m_occupied);
+            swap(m_dec_capacity, t.m_dec_capacity);
+            swap(m_hash_shift, t.m_hash_shift);
+            swap(m_size, t.m_size);
+        }
+
+    private:
+        allocator_type m_allocator;
+
+        bucket_type* m_bucket       = nullptr;
+        bucket_type* m_bucket_end   = nullptr;
+        uint64_t* m_occupied        = nullptr;
+
+        size_type m_dec_capacity    = 0;
+        uint8_t m_hash_shift        = 0;
+        size_type m_size            = 0;
+
+        inline bucket_type* retreat(bucket_type* iter) const noexcept {
+            if (JVN_UNLIKELY(iter == m_bucket))
+                return m_bucket_end - 1;
+
+            return iter - 1;
+        }
+
+        // Moves the elements from iter up to the next empty bucket one bucket forward,
+        // leaving iter unconstructed. The cluster stays ordered by home bucket
+        size_type shiftForward(bucket_type* iter) {
+            size_type shifted = 1;
+            bucket_type* last = advance(iter);
+            while (last->id != uint8_t(-1)) {
+                last = advance(last);
+                ++shifted;
+            }
+
+            bucket_type* prev = retreat(last);
+            traits::move_construct(*last, *prev);
+            last->id = prev->id + 1;
+            markOccupied(last);
+            while (prev != iter) {
+                bucket_type* before = retreat(prev);
+                traits::swap(*prev, *before);
+                prev->id = before->id + 1;
+                prev = before;
+            }
+
+            traits::destroy(*iter);
+            return shifted;
+        }
+
+        // Leaves the old array, if any, to the caller. The table is unchanged on bad_alloc()
+        void initilize(size_type capacity) {
+            // +1 is for the differantiation of the end() iterator
+            bucket_type* new_bucket = m_allocator.allocate(capacity + 1);
+            if (new_bucket == nullptr)
+                throw std::bad_alloc();
+
+            uint64_t* new_occupied = nullptr;
+            if constexpr (M_OCCUPANCY_BITMAP) {
+                try {
+                    new_occupied = m_word_allocator(m_allocator).allocate(wordCount(capacity));
+                }
+                catch (...) {
+                    m_allocator.deallocate(new_bucket, capacity + 1);
+                    throw;
+                }
+                std::memset(new_occupied, 0, wordCount(capacity) * sizeof(uint64_t));
+            }
+
+            m_dec_capacity = capacity - 1;
+            m_size = 0;
+
+            m_hash_shift = hashShift(capacity);
+
+            m_bucket = new_bucket;
+            m_bucket_end = m_bucket + capacity;
+            m_occupied = new_occupied;
+            for (bucket_type* iter = m_bucket; iter != m_bucket_end; ++iter)
+                iter->id = uint8_t(-1);
+
+            //Element at the end must have a non -1u info value
+            m_bucket_end->id = uint8_t(0);
+        }
+
+        void deallocate() noexcept {
+            if (m_bucket)
+                m_allocator.deallocate(m_bucket, m_dec_capacity + 2);
+            if (m_occupied)
+                m_word_allocator(m_allocator).deallocate(m_occupied, wordCount(capacity()));
+        }
+
+        // Words in the occupancy bitmap, 0 without one
+        static inline size_type wordCount(size_type capacity) noexcept { return M_OCCUPANCY_BITMAP ? (capacity + 63) / 64 : 0; }
+
+        inline void markOccupied(const bucket_type* iter) noexcept {
+            if constexpr (M_OCCUPANCY_BITMAP) {
+                size_type index = size_type(iter - m_bucket);
+                m_occupied[index / 64] |= uint64_t(1) << (index % 64);
+            }
+        }
+
+        inline void markEmpty(const bucket_type* iter) noexcept {
+            if constexpr (M_OCCUPANCY_BITMAP) {
+                size_type index = size_type(iter - m_bucket);
+                m_occupied[index / 64] &= ~(uint64_t(1) << (index % 64));
+            }
+        }
+    };
+
+} // namespace detail
+
+} // namespace jvn
+
+#endif
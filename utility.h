@@ -31,6 +31,16 @@
 #    define JVN_UNLIKELY(condition) __builtin_expect(condition, 0)
 #endif
 
+// prefetch
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#    include <xmmintrin.h>
+#    define JVN_PREFETCH(address) _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0)
+#elif defined(_MSC_VER)
+#    define JVN_PREFETCH(address)
+#else
+#    define JVN_PREFETCH(address) __builtin_prefetch(address)
+#endif
+
 // pragma
 #ifdef _MSC_VER
     #define JVN_PRAGMA_PACK_PUSH(n)  __pragma(pack(push, n))
@@ -40,6 +50,24 @@
     #define JVN_PRAGMA_PACK_POP()   _Pragma("pack(pop)")
 #endif
 
+// runtime statistics
+// Opt-in with #define JVN_ENABLE_STATS before including map.h
+#ifdef JVN_ENABLE_STATS
+#    define JVN_DEFINITION_STATS() 1
+#    define JVN_STATS(statement) statement
+#else
+#    define JVN_DEFINITION_STATS() 0
+#    define JVN_STATS(statement)
+#endif
+
+// occupancy bitmap
+// Opt-in with #define JVN_ENABLE_OCCUPANCY_BITMAP before including the maps, consistently across the program
+#ifdef JVN_ENABLE_OCCUPANCY_BITMAP
+#    define JVN_DEFINITION_OCCUPANCY_BITMAP() 1
+#else
+#    define JVN_DEFINITION_OCCUPANCY_BITMAP() 0
+#endif
+
 // End custom macro  -----------------------------------
 
 #endif
\ No newline at end of file